@@ -0,0 +1,93 @@
+#ifndef MICROSIM_H
+#define MICROSIM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+* C API for embedding the MicroSim emulator.
+*
+* Functions which can fail return a microsim_status. When they do, microsim_last_error gives a description
+* of the most recent error, which stays valid until the next call using the same emulator.
+*
+* Memory and register views point directly at the emulator's state, so writes through them are seen by the
+* emulator. They stay valid until the emulator is destroyed.
+*/
+
+// MICROSIM_SHARED is defined when microsim_core is a shared library, and MICROSIM_BUILDING while building it
+#if defined(_WIN32) && defined(MICROSIM_SHARED)
+#ifdef MICROSIM_BUILDING
+#define MICROSIM_API __declspec(dllexport)
+#else
+#define MICROSIM_API __declspec(dllimport)
+#endif
+#else
+#define MICROSIM_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct microsim_emulator microsim_emulator;
+
+typedef enum microsim_status {
+	MICROSIM_OK = 0,
+	MICROSIM_ERROR_INVALID_DATA = 1, // Invalid instruction, or a program which does not fit in memory
+	MICROSIM_ERROR_LOADER = 2, // Program file could not be read or parsed
+	MICROSIM_ERROR_UNKNOWN = 3
+} microsim_status;
+
+typedef struct microsim_view {
+	uint32_t* data;
+	size_t length;
+} microsim_view;
+
+// Returns NULL if the emulator could not be allocated
+MICROSIM_API microsim_emulator* microsim_create(void);
+MICROSIM_API void microsim_destroy(microsim_emulator* emulator);
+
+// Loading a program wipes memory, registers (including PC) and flags, copies the program to address 0, and does the
+// same as microsim_reset, so that the program runs from the start
+MICROSIM_API microsim_status microsim_load(microsim_emulator* emulator, const uint32_t* program, size_t length);
+MICROSIM_API microsim_status microsim_load_file(microsim_emulator* emulator, const char* path);
+
+// Clears the halted and idle state and sets the instruction count to 0, so that microsim_step and microsim_run execute
+// again. Memory, registers (including PC) and flags are left unchanged, so a halted program continues from where
+// it stopped. To restart a program from the beginning, load it again, or restore a snapshot saved straight after loading.
+MICROSIM_API void microsim_reset(microsim_emulator* emulator);
+
+MICROSIM_API microsim_status microsim_step(microsim_emulator* emulator);
+
+// Runs until the program halts or instruction_limit instructions have been executed
+// The number of instructions executed is written to executed, if it is not NULL
+MICROSIM_API microsim_status microsim_run(microsim_emulator* emulator, uint64_t instruction_limit, uint64_t* executed);
+
+MICROSIM_API int microsim_finished(microsim_emulator* emulator);
+MICROSIM_API int microsim_idle(microsim_emulator* emulator);
+MICROSIM_API uint64_t microsim_instructions_executed(microsim_emulator* emulator);
+
+MICROSIM_API microsim_view microsim_memory(microsim_emulator* emulator);
+MICROSIM_API microsim_view microsim_registers(microsim_emulator* emulator);
+
+// Unlike writing through microsim_memory, writes made here are undone by microsim_restore_snapshot
+MICROSIM_API microsim_status microsim_write_memory(microsim_emulator* emulator, uint32_t address, const uint32_t* data, size_t length);
+
+// Restoring only copies back the memory pages which have been written since the snapshot was saved
+MICROSIM_API void microsim_save_snapshot(microsim_emulator* emulator);
+MICROSIM_API void microsim_restore_snapshot(microsim_emulator* emulator);
+
+// Records edge coverage of taken branches into map, whose size must be a power of two up to 2^31 (NULL disables coverage)
+// Any other size returns MICROSIM_ERROR_INVALID_DATA and leaves coverage unchanged
+MICROSIM_API microsim_status microsim_set_coverage_map(microsim_emulator* emulator, uint8_t* map, size_t size);
+
+// Flags are a combination of the CCR_FLAGS bits (Z = 8, C = 4, N = 2, V = 1)
+MICROSIM_API uint8_t microsim_flags(microsim_emulator* emulator);
+
+MICROSIM_API const char* microsim_last_error(microsim_emulator* emulator);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -24,6 +24,7 @@ namespace MicroSim {
 
 	// 16 user-accessible registers, plus 1 additional register (CIR)
 	const uint8_t REGISTER_COUNT = 17;
+	const uint8_t USER_REGISTER_COUNT = 16;
 
 	// User-accessible registers
 	const uint8_t SP_INDEX = 14;
@@ -131,6 +132,13 @@ namespace MicroSim {
 		{ OP_ASR, { MODE_IMMEDIATE, MODE_REGISTER } },
 	};
 
+	// Loops whose backward branch spans at most this many instructions are checked for idling
+	const uint32_t IDLE_LOOP_MAX_LENGTH = 16;
+
+	// Memory is split into pages, so that restoring a snapshot only needs to copy pages which have been written to
+	const uint32_t PAGE_SIZE = 1 << 8;
+	const uint32_t PAGE_COUNT = MEMORY_SIZE / PAGE_SIZE;
+
 	const uint32_t SIGN_BIT_MASK = 1 << 19; // 20th bit is the sign
 	const uint32_t NUMBER_MASK = 0x000fffff; // Least significant 20 bits are used for calculations
 }
\ No newline at end of file
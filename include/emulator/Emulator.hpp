@@ -1,6 +1,7 @@
 #pragma once
 
 #include <algorithm>
+#include <iterator>
 
 #include "Constants.hpp"
 #include "Exceptions.hpp"
@@ -11,21 +12,55 @@ namespace MicroSim {
 		Emulator();
 
 		void step();
+		// Runs until the program halts or instruction_limit more instructions have been executed (the limit is relative)
+		// Returns the number of instructions executed, which is less than the limit only if the program halted,
+		// or if an idle loop would have made instructions_executed() overflow
+		uint64_t run(uint64_t instruction_limit);
 
 		void fetch();
 		void decode();
 		void execute();
 
 		bool finished();
+		bool idle();
+		// Clears the halted and idle state and the instruction count, but leaves memory, registers and flags unchanged
 		void reset();
 
+		// Wipes memory, registers and flags, copies the program to address 0, then resets
+		void load(const uint32_t* program, size_t length);
+
+		// Copies data into memory, which (unlike writing through get_memory) is undone by restore_snapshot
+		void write_memory(uint32_t address, const uint32_t* data, size_t length);
+
+		// Saves the whole emulator state, so that it can be cheaply restored after each run (e.g. when fuzzing)
+		// Only pages written by the program or write_memory since the snapshot are copied back
+		// Loading a program discards the snapshot
+		void save_snapshot();
+		void restore_snapshot();
+		bool has_snapshot();
+
+		// Records edge coverage of taken branches into map, which must be a power of two in size (up to 2^31)
+		// Throws InvalidCoverageMapSize otherwise, and passing nullptr disables coverage
+		void set_coverage_map(uint8_t* map, size_t size);
+
+		uint64_t instructions_executed();
+
+		// Direct access to the emulator's state, without copying
+		// Memory is MEMORY_SIZE words long, and registers is REGISTER_COUNT words long
+		uint32_t* get_memory();
+		uint32_t* get_registers();
+		uint8_t get_flags();
+
+		// Indices of the pages written since the last snapshot was saved or restored
+		const std::vector<uint32_t>& get_dirty_pages();
+
 	private:
 
 		struct Instruction {
 			Opcode opcode;
 			AddressingMode mode;
 			uint8_t register_a, register_b;
-			uint16_t operand;
+			uint32_t operand; // 20 bits
 			
 			// Either operand or register_b should be used (never both)
 		};
@@ -34,8 +69,33 @@ namespace MicroSim {
 			uint8_t c, z, n, v;
 		};
 
+		// Machine state recorded at a backward branch, used to detect loops which can never exit
+		struct IdleLoopCandidate {
+			uint32_t branch_address;
+			uint32_t registers[REGISTER_COUNT];
+			CCR ccr;
+			uint64_t instructions_executed;
+			bool valid;
+		};
+
+		struct Snapshot {
+			std::vector<uint32_t> memory;
+			uint32_t registers[REGISTER_COUNT];
+			CCR ccr;
+			Instruction current_instruction;
+			bool finished;
+			uint64_t instructions_executed;
+		};
+
 		Instruction decode_instruction(uint32_t instruction);
 
+		void branch(uint32_t target);
+
+		void mark_dirty(uint32_t address, size_t length);
+
+		// Returns the length of the loop iteration in instructions if the loop can never exit, otherwise 0
+		uint64_t idle_loop_period(uint32_t branch_address);
+
 		bool opcode_supports_addressing_mode(Opcode opcode, AddressingMode mode);
 
 		uint32_t memory[MEMORY_SIZE] = { }; // Set all memory to zeroes
@@ -46,5 +106,20 @@ namespace MicroSim {
 		Instruction current_instruction = { Opcode::OP_HLT, AddressingMode::MODE_IMPLICIT, 0, 0, 0 };
 
 		bool _finished = true;
+		bool _idle = false;
+
+		uint64_t _instructions_executed = 0;
+
+		IdleLoopCandidate idle_candidate = { };
+		bool memory_written = false;
+
+		Snapshot snapshot;
+		bool _has_snapshot = false;
+
+		bool dirty[PAGE_COUNT] = { };
+		std::vector<uint32_t> dirty_pages;
+
+		uint8_t* coverage_map = nullptr;
+		uint32_t coverage_mask = 0;
 	};
 }
@@ -31,4 +31,37 @@ namespace MicroSim {
 		InvalidOpcode() : InvalidDataError("Invalid opcode: Opcode is not recognised.") { }
 		InvalidOpcode(int opcode) : InvalidDataError("Invalid opcode: " + std::to_string(opcode) + " is not recognised as a valid opcode.") { }
 	};
+
+	class ProgramTooLarge : public InvalidDataError {
+	public:
+		ProgramTooLarge() : InvalidDataError("Program too large: Program does not fit in memory.") { }
+		ProgramTooLarge(size_t length) : InvalidDataError("Program too large: " + std::to_string(length) + " words do not fit in " + std::to_string(MEMORY_SIZE) + " memory locations.") { }
+	};
+
+	class InvalidAddress : public InvalidDataError {
+	public:
+		InvalidAddress() : InvalidDataError("Invalid address: Address is outside of memory.") { }
+		InvalidAddress(uint32_t address, size_t length) : InvalidDataError("Invalid address: " + std::to_string(length) + " words from address " + std::to_string(address) + " do not fit in memory.") { }
+	};
+
+	class InvalidCoverageMapSize : public InvalidDataError {
+	public:
+		InvalidCoverageMapSize() : InvalidDataError("Invalid coverage map size: Size must be a power of two between 1 and 2^31.") { }
+		InvalidCoverageMapSize(size_t size) : InvalidDataError("Invalid coverage map size: " + std::to_string(size) + " is not a power of two between 1 and 2^31.") { }
+	};
+
+	class LoaderError : public EmulatorError {
+		using EmulatorError::EmulatorError;
+	};
+
+	class FileNotReadable : public LoaderError {
+	public:
+		FileNotReadable(const std::string& path) : LoaderError("File not readable: " + path + " could not be opened.") { }
+	};
+
+	class InvalidProgramFile : public LoaderError {
+	public:
+		InvalidProgramFile(const std::string& path) : LoaderError("Invalid program file: " + path + " is not a valid program.") { }
+		InvalidProgramFile(const std::string& path, size_t line) : LoaderError("Invalid program file: " + path + " has an invalid word on line " + std::to_string(line) + ".") { }
+	};
 }
\ No newline at end of file
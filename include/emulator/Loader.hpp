@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Constants.hpp"
+#include "Exceptions.hpp"
+
+namespace MicroSim {
+	/*
+	* Program file formats:
+	* - Binary: a raw memory image of 32-bit little-endian words, loaded from address 0
+	* - Hex: one word per line in hexadecimal, loaded from address 0
+	*   Anything after a ';' is a comment, and blank lines are ignored
+	*/
+
+	std::vector<uint32_t> load_binary(const std::string& path);
+	std::vector<uint32_t> load_hex(const std::string& path);
+
+	// Chooses the format based on the file extension (".hex" is hex, anything else is binary)
+	std::vector<uint32_t> load_program(const std::string& path);
+}
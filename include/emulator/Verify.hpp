@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "Emulator.hpp"
+
+namespace MicroSim {
+	/*
+	* Checks that run() (which fast-forwards idle loops) behaves exactly like stepping each instruction.
+	*
+	* Instruction limits are relative to the emulator's current instruction count, as with run().
+	* Errors from the program are caught and returned as their message, which is empty if there was no error.
+	*/
+
+	std::string run_to_limit(Emulator& emulator, uint64_t instruction_limit);
+	std::string step_to_limit(Emulator& emulator, uint64_t instruction_limit);
+
+	// Both emulators must be in the same state, straight after load() or restore_snapshot(), since only memory pages
+	// written after that are compared
+	// fast is executed with run_to_limit and reference with step_to_limit, and error is set to fast's error
+	bool run_matches_step(Emulator& fast, Emulator& reference, uint64_t instruction_limit, std::string& error);
+}
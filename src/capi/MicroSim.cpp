@@ -0,0 +1,119 @@
+#include "MicroSim.h"
+
+#include <new>
+
+#include "Emulator.hpp"
+#include "Loader.hpp"
+
+struct microsim_emulator {
+	MicroSim::Emulator emulator;
+	std::string last_error;
+};
+
+namespace {
+	// Exceptions must not cross the C boundary, so convert them into a status and keep the message
+	template <typename F>
+	microsim_status guard(microsim_emulator* emulator, F function) {
+		try {
+			function();
+			emulator->last_error.clear();
+			return MICROSIM_OK;
+		}
+		catch (const MicroSim::InvalidDataError& e) {
+			emulator->last_error = e.what();
+			return MICROSIM_ERROR_INVALID_DATA;
+		}
+		catch (const MicroSim::LoaderError& e) {
+			emulator->last_error = e.what();
+			return MICROSIM_ERROR_LOADER;
+		}
+		catch (const std::exception& e) {
+			emulator->last_error = e.what();
+			return MICROSIM_ERROR_UNKNOWN;
+		}
+	}
+}
+
+extern "C" {
+	microsim_emulator* microsim_create(void) {
+		// The emulator holds all of memory, so it is always allocated on the heap
+		return new (std::nothrow) microsim_emulator();
+	}
+
+	void microsim_destroy(microsim_emulator* emulator) {
+		delete emulator;
+	}
+
+	microsim_status microsim_load(microsim_emulator* emulator, const uint32_t* program, size_t length) {
+		return guard(emulator, [&]() { emulator->emulator.load(program, length); });
+	}
+
+	microsim_status microsim_load_file(microsim_emulator* emulator, const char* path) {
+		return guard(emulator, [&]() {
+			std::vector<uint32_t> program = MicroSim::load_program(path);
+			emulator->emulator.load(program.data(), program.size());
+		});
+	}
+
+	void microsim_reset(microsim_emulator* emulator) {
+		emulator->emulator.reset();
+	}
+
+	microsim_status microsim_step(microsim_emulator* emulator) {
+		return guard(emulator, [&]() { emulator->emulator.step(); });
+	}
+
+	microsim_status microsim_run(microsim_emulator* emulator, uint64_t instruction_limit, uint64_t* executed) {
+		uint64_t start = emulator->emulator.instructions_executed();
+
+		microsim_status status = guard(emulator, [&]() { emulator->emulator.run(instruction_limit); });
+
+		if (executed) *executed = emulator->emulator.instructions_executed() - start;
+
+		return status;
+	}
+
+	int microsim_finished(microsim_emulator* emulator) {
+		return emulator->emulator.finished();
+	}
+
+	int microsim_idle(microsim_emulator* emulator) {
+		return emulator->emulator.idle();
+	}
+
+	uint64_t microsim_instructions_executed(microsim_emulator* emulator) {
+		return emulator->emulator.instructions_executed();
+	}
+
+	microsim_view microsim_memory(microsim_emulator* emulator) {
+		return { emulator->emulator.get_memory(), MicroSim::MEMORY_SIZE };
+	}
+
+	microsim_view microsim_registers(microsim_emulator* emulator) {
+		return { emulator->emulator.get_registers(), MicroSim::REGISTER_COUNT };
+	}
+
+	microsim_status microsim_write_memory(microsim_emulator* emulator, uint32_t address, const uint32_t* data, size_t length) {
+		return guard(emulator, [&]() { emulator->emulator.write_memory(address, data, length); });
+	}
+
+	void microsim_save_snapshot(microsim_emulator* emulator) {
+		emulator->emulator.save_snapshot();
+	}
+
+	void microsim_restore_snapshot(microsim_emulator* emulator) {
+		emulator->emulator.restore_snapshot();
+	}
+
+	microsim_status microsim_set_coverage_map(microsim_emulator* emulator, uint8_t* map, size_t size) {
+		return guard(emulator, [&]() { emulator->emulator.set_coverage_map(map, size); });
+	}
+
+	uint8_t microsim_flags(microsim_emulator* emulator) {
+		return emulator->emulator.get_flags();
+	}
+
+	const char* microsim_last_error(microsim_emulator* emulator) {
+		return emulator->last_error.c_str();
+	}
+}
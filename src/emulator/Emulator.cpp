@@ -9,12 +9,58 @@ namespace MicroSim {
 		fetch();
 		decode();
 		execute();
+
+		// Saturate rather than wrap around, since idle loops can fast-forward the counter close to its limit
+		if (_instructions_executed != UINT64_MAX) _instructions_executed++;
+	}
+
+	uint64_t Emulator::run(uint64_t instruction_limit) {
+		uint64_t start = _instructions_executed;
+
+		// Memory may have been changed externally since the last run, so any previous candidate can't be trusted
+		idle_candidate.valid = false;
+		_idle = false;
+
+		// Also stop if the counter is full, since the instructions executed could no longer be counted
+		while (!_finished && _instructions_executed - start < instruction_limit && _instructions_executed != UINT64_MAX) {
+			uint32_t address = registers[PC_INDEX];
+
+			step();
+
+			// Only backward jumps over a short distance can be idle loops
+			uint32_t target = registers[PC_INDEX];
+			if (target > address || address - target >= IDLE_LOOP_MAX_LENGTH) continue;
+
+			uint64_t period = idle_loop_period(address);
+			if (period != 0) {
+				// The program will repeat the same iteration forever, so skip every whole iteration left in the budget
+				// Any remaining partial iteration is still stepped normally so that the final state is exact
+				uint64_t remaining = instruction_limit - (_instructions_executed - start);
+				uint64_t skipped = remaining - remaining % period;
+
+				// Don't let the counter wrap around (e.g. if the limit is UINT64_MAX to mean "no limit")
+				// If the counter can't hold the whole skip, stop after the last iteration it can hold
+				uint64_t headroom = UINT64_MAX - _instructions_executed;
+				bool saturated = skipped > headroom;
+				if (saturated) skipped = headroom - headroom % period;
+
+				_instructions_executed += skipped;
+				idle_candidate.instructions_executed = _instructions_executed;
+
+				_idle = true;
+
+				if (saturated) break;
+			}
+		}
+
+		return _instructions_executed - start;
 	}
 
 	void Emulator::fetch() {
 		// TODO: fetch
 		// TODO: not sure if this is correct, but it might be?
-		registers[CIR_INDEX] = memory[registers[PC_INDEX]];
+		// Addresses are 20 bits, so wrap around in case the program counter has been set outside of memory
+		registers[CIR_INDEX] = memory[registers[PC_INDEX] & NUMBER_MASK];
 
 		// Increment program counter
 		registers[PC_INDEX]++;
@@ -36,7 +82,8 @@ namespace MicroSim {
 		case AddressingMode::MODE_REGISTER:
 		case AddressingMode::MODE_INDIRECT:
 			// Get the literal value or memory address specified by register_b, and store it in the operand
-			current_instruction.operand = registers[current_instruction.register_b];
+			// Only the least significant 20 bits are used, so that memory addresses can't be out of range
+			current_instruction.operand = registers[current_instruction.register_b] & NUMBER_MASK;
 			break;
 
 		default:
@@ -68,6 +115,8 @@ namespace MicroSim {
 		case Opcode::OP_STR: // Store
 			// Copy register to memory location specified by operand
 			memory[current_instruction.operand] = registers[current_instruction.register_a];
+			memory_written = true;
+			mark_dirty(current_instruction.operand, 1);
 			break;
 
 		case Opcode::OP_ADD: // Add
@@ -379,39 +428,39 @@ namespace MicroSim {
 			break;
 		}
 		case Opcode::OP_BCC: // Branch if carry clear (C = 0)
-			if (ccr.c == 0) registers[PC_INDEX] = current_instruction.operand;
+			if (ccr.c == 0) branch(current_instruction.operand);
 			break;
 
 		case Opcode::OP_BCS: // Branch if carry set (C = 1)
-			if (ccr.c == 1) registers[PC_INDEX] = current_instruction.operand;
+			if (ccr.c == 1) branch(current_instruction.operand);
 			break;
 
 		case Opcode::OP_BPL: // Branch if plus (N = 0) i.e. positive or zero
-			if (ccr.n == 0) registers[PC_INDEX] = current_instruction.operand;
+			if (ccr.n == 0) branch(current_instruction.operand);
 			break;
 
 		case Opcode::OP_BMI: // Branch if minus (N = 1) i.e. negative
-			if (ccr.n == 1) registers[PC_INDEX] = current_instruction.operand;
+			if (ccr.n == 1) branch(current_instruction.operand);
 			break;
 
 		case Opcode::OP_BNE: // Branch if not equal (Z = 0) i.e. not zero
-			if (ccr.z == 0) registers[PC_INDEX] = current_instruction.operand;
+			if (ccr.z == 0) branch(current_instruction.operand);
 			break;
 
 		case Opcode::OP_BEQ: // Branch if equal (Z = 1) i.e. zero
-			if (ccr.z == 1) registers[PC_INDEX] = current_instruction.operand;
+			if (ccr.z == 1) branch(current_instruction.operand);
 			break;
 
 		case Opcode::OP_BVC: // Branch if overflow clear (V = 0)
-			if (ccr.v == 0) registers[PC_INDEX] = current_instruction.operand;
+			if (ccr.v == 0) branch(current_instruction.operand);
 			break;
 
 		case Opcode::OP_BVS: // Branch if overflow set (V = 1)
-			if (ccr.v == 1) registers[PC_INDEX] = current_instruction.operand;
+			if (ccr.v == 1) branch(current_instruction.operand);
 			break;
 
 		case Opcode::OP_JMP: // Jump unconditionally
-			registers[PC_INDEX] = current_instruction.operand;
+			branch(current_instruction.operand);
 			break;
 
 		case Opcode::OP_CMP: // Compare
@@ -443,6 +492,10 @@ namespace MicroSim {
 
 	void Emulator::reset() {
 		_finished = false;
+		_idle = false;
+
+		_instructions_executed = 0;
+		idle_candidate.valid = false;
 
 		// TODO: wipe memory? or maybe should be wiped when program is loaded in again?
 		// Maybe need to store a copy of the memory or program?
@@ -452,6 +505,117 @@ namespace MicroSim {
 		return _finished;
 	}
 
+	void Emulator::load(const uint32_t* program, size_t length) {
+		if (length > MEMORY_SIZE) {
+			throw ProgramTooLarge(length);
+		}
+
+		// Wipe any previous program and state, then copy the new program to the start of memory
+		std::fill(std::begin(memory), std::end(memory), 0);
+		std::fill(std::begin(registers), std::end(registers), 0);
+		std::copy(program, program + length, std::begin(memory));
+
+		// The snapshot only tracks pages written since it was taken, so it is no longer usable
+		_has_snapshot = false;
+		for (uint32_t page : dirty_pages) dirty[page] = false;
+		dirty_pages.clear();
+
+		ccr = { 0, 0, 0, 0 };
+		current_instruction = { Opcode::OP_HLT, AddressingMode::MODE_IMPLICIT, 0, 0, 0 };
+
+		reset();
+	}
+
+	void Emulator::write_memory(uint32_t address, const uint32_t* data, size_t length) {
+		if (address > MEMORY_SIZE || length > MEMORY_SIZE - address) {
+			throw InvalidAddress(address, length);
+		}
+
+		std::copy(data, data + length, std::begin(memory) + address);
+		mark_dirty(address, length);
+	}
+
+	void Emulator::save_snapshot() {
+		snapshot.memory.assign(std::begin(memory), std::end(memory));
+		std::copy(std::begin(registers), std::end(registers), std::begin(snapshot.registers));
+		snapshot.ccr = ccr;
+		snapshot.current_instruction = current_instruction;
+		snapshot.finished = _finished;
+		snapshot.instructions_executed = _instructions_executed;
+
+		for (uint32_t page : dirty_pages) dirty[page] = false;
+		dirty_pages.clear();
+
+		_has_snapshot = true;
+	}
+
+	void Emulator::restore_snapshot() {
+		if (!_has_snapshot) return;
+
+		// Only copy back the pages which have changed
+		for (uint32_t page : dirty_pages) {
+			auto start = snapshot.memory.begin() + page * PAGE_SIZE;
+			std::copy(start, start + PAGE_SIZE, std::begin(memory) + page * PAGE_SIZE);
+			dirty[page] = false;
+		}
+		dirty_pages.clear();
+
+		std::copy(std::begin(snapshot.registers), std::end(snapshot.registers), std::begin(registers));
+		ccr = snapshot.ccr;
+		current_instruction = snapshot.current_instruction;
+		_finished = snapshot.finished;
+		_instructions_executed = snapshot.instructions_executed;
+
+		_idle = false;
+		idle_candidate.valid = false;
+	}
+
+	bool Emulator::has_snapshot() {
+		return _has_snapshot;
+	}
+
+	void Emulator::set_coverage_map(uint8_t* map, size_t size) {
+		// The size is used as a mask, so anything else would index outside the map or leave part of it unused
+		// The mask is 32 bits, so larger maps aren't supported
+		if (map && (size == 0 || (size & (size - 1)) != 0 || size > (static_cast<size_t>(1) << 31))) {
+			throw InvalidCoverageMapSize(size);
+		}
+
+		coverage_map = map;
+		coverage_mask = map ? static_cast<uint32_t>(size - 1) : 0;
+	}
+
+	bool Emulator::idle() {
+		return _idle;
+	}
+
+	uint64_t Emulator::instructions_executed() {
+		return _instructions_executed;
+	}
+
+	uint32_t* Emulator::get_memory() {
+		return memory;
+	}
+
+	uint32_t* Emulator::get_registers() {
+		return registers;
+	}
+
+	uint8_t Emulator::get_flags() {
+		uint8_t flags = 0;
+
+		if (ccr.z) flags |= CCR_Z;
+		if (ccr.c) flags |= CCR_C;
+		if (ccr.n) flags |= CCR_N;
+		if (ccr.v) flags |= CCR_V;
+
+		return flags;
+	}
+
+	const std::vector<uint32_t>& Emulator::get_dirty_pages() {
+		return dirty_pages;
+	}
+
 
 	Emulator::Instruction Emulator::decode_instruction(uint32_t instruction) {
 		Instruction decoded_instruction;
@@ -489,8 +653,65 @@ namespace MicroSim {
 		return decoded_instruction;
 	}
 
+	void Emulator::branch(uint32_t target) {
+		if (coverage_map) {
+			// The branch instruction is the one before the (already incremented) program counter
+			// Hashing the source means that A -> B and B -> A are recorded as different edges
+			uint32_t source = registers[PC_INDEX] - 1;
+			uint8_t& counter = coverage_map[((source * 0x9e3779b1) ^ target) & coverage_mask];
+
+			// Saturate rather than wrap around, otherwise a hot edge would look uncovered after 256 hits
+			if (counter != UINT8_MAX) counter++;
+		}
+
+		registers[PC_INDEX] = target;
+	}
+
+	void Emulator::mark_dirty(uint32_t address, size_t length) {
+		if (length == 0) return;
+
+		uint32_t first = address / PAGE_SIZE;
+		uint32_t last = static_cast<uint32_t>((address + length - 1) / PAGE_SIZE);
+
+		for (uint32_t page = first; page <= last; page++) {
+			if (!dirty[page]) {
+				dirty[page] = true;
+				dirty_pages.push_back(page);
+			}
+		}
+	}
+
+	uint64_t Emulator::idle_loop_period(uint32_t branch_address) {
+		// If the same backward branch is taken twice with identical registers and flags, and nothing was stored in between,
+		// then the loop is a fixed point: memory is unchanged, so every following iteration must be identical too
+		// There are no devices which can write to memory, so this holds until the program is externally interrupted
+		bool repeated = idle_candidate.valid && !memory_written &&
+			idle_candidate.branch_address == branch_address &&
+			std::equal(std::begin(registers), std::end(registers), std::begin(idle_candidate.registers)) &&
+			idle_candidate.ccr.c == ccr.c && idle_candidate.ccr.z == ccr.z && idle_candidate.ccr.n == ccr.n && idle_candidate.ccr.v == ccr.v;
+
+		uint64_t period = repeated ? _instructions_executed - idle_candidate.instructions_executed : 0;
+
+		// Record the current state as the candidate for the next check
+		idle_candidate.branch_address = branch_address;
+		std::copy(std::begin(registers), std::end(registers), std::begin(idle_candidate.registers));
+		idle_candidate.ccr = ccr;
+		idle_candidate.instructions_executed = _instructions_executed;
+		idle_candidate.valid = true;
+
+		memory_written = false;
+
+		return period;
+	}
+
 	bool Emulator::opcode_supports_addressing_mode(Opcode opcode, AddressingMode mode) {
-		const std::vector<AddressingMode>& supported_modes = SUPPORTED_ADDRESSING_MODES.at(opcode);
+		auto it = SUPPORTED_ADDRESSING_MODES.find(opcode);
+		if (it == SUPPORTED_ADDRESSING_MODES.end()) {
+			// Opcode was not recognised
+			throw InvalidOpcode(opcode);
+		}
+
+		const std::vector<AddressingMode>& supported_modes = it->second;
 		return std::find(supported_modes.begin(), supported_modes.end(), mode) != supported_modes.end();
 	}
 }
\ No newline at end of file
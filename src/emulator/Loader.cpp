@@ -0,0 +1,85 @@
+#include "Loader.hpp"
+
+#include <fstream>
+#include <iterator>
+
+namespace MicroSim {
+	std::vector<uint32_t> load_binary(const std::string& path) {
+		std::ifstream file(path, std::ios::binary);
+		if (!file) {
+			throw FileNotReadable(path);
+		}
+
+		std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+		// Every word must be complete
+		if (bytes.size() % 4 != 0) {
+			throw InvalidProgramFile(path);
+		}
+
+		if (bytes.size() / 4 > MEMORY_SIZE) {
+			throw ProgramTooLarge(bytes.size() / 4);
+		}
+
+		std::vector<uint32_t> program(bytes.size() / 4);
+
+		for (size_t i = 0; i < program.size(); i++) {
+			// Words are little-endian, regardless of the host
+			program[i] = bytes[i * 4] | (bytes[i * 4 + 1] << 8) | (bytes[i * 4 + 2] << 16) | (static_cast<uint32_t>(bytes[i * 4 + 3]) << 24);
+		}
+
+		return program;
+	}
+
+	std::vector<uint32_t> load_hex(const std::string& path) {
+		std::ifstream file(path);
+		if (!file) {
+			throw FileNotReadable(path);
+		}
+
+		std::vector<uint32_t> program;
+
+		std::string line;
+		size_t line_number = 0;
+
+		while (std::getline(file, line)) {
+			line_number++;
+
+			// Remove comments and surrounding whitespace
+			line = line.substr(0, line.find(';'));
+
+			size_t first = line.find_first_not_of(" \t\r");
+			if (first == std::string::npos) continue;
+
+			size_t last = line.find_last_not_of(" \t\r");
+			line = line.substr(first, last - first + 1);
+
+			// Allow an optional 0x prefix
+			if (line.size() > 2 && line[0] == '0' && (line[1] == 'x' || line[1] == 'X')) {
+				line = line.substr(2);
+			}
+
+			if (line.size() > 8 || line.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos) {
+				throw InvalidProgramFile(path, line_number);
+			}
+
+			if (program.size() == MEMORY_SIZE) {
+				throw ProgramTooLarge(program.size() + 1);
+			}
+
+			program.push_back(static_cast<uint32_t>(std::stoul(line, nullptr, 16)));
+		}
+
+		return program;
+	}
+
+	std::vector<uint32_t> load_program(const std::string& path) {
+		const std::string hex_extension = ".hex";
+
+		if (path.size() >= hex_extension.size() && path.compare(path.size() - hex_extension.size(), hex_extension.size(), hex_extension) == 0) {
+			return load_hex(path);
+		}
+
+		return load_binary(path);
+	}
+}
@@ -0,0 +1,60 @@
+#include "Verify.hpp"
+
+#include <cstring>
+
+namespace MicroSim {
+	namespace {
+		bool memory_equal(Emulator& a, Emulator& b) {
+			// Both emulators started from identical memory, so only pages which either has written can differ
+			for (Emulator* emulator : { &a, &b }) {
+				for (uint32_t page : emulator->get_dirty_pages()) {
+					uint32_t offset = page * PAGE_SIZE;
+
+					if (std::memcmp(a.get_memory() + offset, b.get_memory() + offset, PAGE_SIZE * sizeof(uint32_t)) != 0) {
+						return false;
+					}
+				}
+			}
+
+			return true;
+		}
+	}
+
+	std::string run_to_limit(Emulator& emulator, uint64_t instruction_limit) {
+		try {
+			emulator.run(instruction_limit);
+		}
+		catch (const EmulatorError& e) {
+			return e.what();
+		}
+
+		return "";
+	}
+
+	std::string step_to_limit(Emulator& emulator, uint64_t instruction_limit) {
+		uint64_t start = emulator.instructions_executed();
+
+		try {
+			while (!emulator.finished() && emulator.instructions_executed() - start < instruction_limit) {
+				emulator.step();
+			}
+		}
+		catch (const EmulatorError& e) {
+			return e.what();
+		}
+
+		return "";
+	}
+
+	bool run_matches_step(Emulator& fast, Emulator& reference, uint64_t instruction_limit, std::string& error) {
+		error = run_to_limit(fast, instruction_limit);
+		std::string reference_error = step_to_limit(reference, instruction_limit);
+
+		return error == reference_error &&
+			fast.finished() == reference.finished() &&
+			fast.instructions_executed() == reference.instructions_executed() &&
+			fast.get_flags() == reference.get_flags() &&
+			std::memcmp(fast.get_registers(), reference.get_registers(), REGISTER_COUNT * sizeof(uint32_t)) == 0 &&
+			memory_equal(fast, reference);
+	}
+}
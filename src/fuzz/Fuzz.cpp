@@ -0,0 +1,195 @@
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Emulator.hpp"
+#include "Loader.hpp"
+#include "Verify.hpp"
+
+/*
+* libFuzzer entry point.
+*
+* By default, the fuzz input is the program itself (as little-endian words loaded from address 0), which fuzzes
+* decoding and execution of arbitrary instructions.
+*
+* If MICROSIM_FUZZ_PROGRAM is set to a program file, that program is loaded instead, and the fuzz input is
+* written to memory at MICROSIM_FUZZ_INPUT_ADDRESS (default 0x80000), which fuzzes the guest program.
+* Inputs are padded with zeroes to whole words, so the input's length in bytes is written to the word just before it.
+*
+* Each input is executed twice from the same snapshot: once with run() (which fast-forwards idle loops) and once
+* by stepping each instruction. Any difference between the two is a bug in the emulator, so it aborts.
+* Stepping doesn't skip idle loops, so setting MICROSIM_FUZZ_DIFFERENTIAL=0 turns this off for faster guest fuzzing.
+*
+* Each run stops after MICROSIM_FUZZ_INSTRUCTION_LIMIT instructions (default 4096). Guests which read all of a large
+* input need a higher limit, at the cost of fewer executions per second.
+*/
+
+namespace {
+	const uint64_t DEFAULT_INSTRUCTION_LIMIT = 1 << 12;
+
+	const uint32_t DEFAULT_INPUT_ADDRESS = 0x80000;
+
+	// Inputs are truncated to this many words, which keeps restoring the snapshot cheap
+	const size_t MAX_INPUT_WORDS = 16 * MicroSim::PAGE_SIZE;
+
+	const size_t COVERAGE_MAP_SIZE = 1 << 16;
+
+	// libFuzzer treats this section as extra counters, so guest control flow guides it as well as the emulator's own
+#if defined(__linux__)
+	__attribute__((section("__libfuzzer_extra_counters")))
+#endif
+	uint8_t guest_coverage[COVERAGE_MAP_SIZE];
+
+	struct Fuzzer {
+		// The emulators hold all of memory, so they are too large for the stack
+		std::unique_ptr<MicroSim::Emulator> primary = std::make_unique<MicroSim::Emulator>();
+		std::unique_ptr<MicroSim::Emulator> reference = std::make_unique<MicroSim::Emulator>();
+
+		// Guest programs are told the length of their input
+		bool guest = false;
+		uint32_t input_address = 0;
+		uint32_t input_length = 0;
+
+		uint64_t instruction_limit = DEFAULT_INSTRUCTION_LIMIT;
+
+		bool differential = true;
+
+		std::vector<uint32_t> input;
+	};
+
+	Fuzzer* fuzzer = nullptr;
+
+	void prepare(MicroSim::Emulator& emulator, const std::vector<uint32_t>& program) {
+		emulator.load(program.data(), program.size());
+		emulator.save_snapshot();
+	}
+
+	// Accepts decimal, hex (0x) or octal (leading 0), and rejects anything else (including negative numbers)
+	bool parse_number(const char* text, uint64_t& value) {
+		if (*text < '0' || *text > '9') return false;
+
+		char* end;
+		errno = 0;
+		value = std::strtoull(text, &end, 0);
+
+		return *end == '\0' && errno == 0;
+	}
+
+	void write_input(MicroSim::Emulator& emulator) {
+		if (fuzzer->guest) {
+			emulator.write_memory(fuzzer->input_address - 1, &fuzzer->input_length, 1);
+		}
+
+		emulator.write_memory(fuzzer->input_address, fuzzer->input.data(), fuzzer->input.size());
+	}
+
+	void report_mismatch(MicroSim::Emulator& primary, MicroSim::Emulator& reference) {
+		for (MicroSim::Emulator* emulator : { &primary, &reference }) {
+			std::fprintf(stderr, "%s:\n", emulator == &primary ? "run" : "step");
+
+			const uint32_t* registers = emulator->get_registers();
+
+			for (uint8_t i = 0; i < MicroSim::REGISTER_COUNT; i++) {
+				std::fprintf(stderr, "  R%-2u = 0x%08x\n", i, registers[i]);
+			}
+
+			std::fprintf(stderr, "  flags = 0x%x, finished = %d, instructions = %llu\n", emulator->get_flags(), emulator->finished(), static_cast<unsigned long long>(emulator->instructions_executed()));
+		}
+	}
+}
+
+extern "C" int LLVMFuzzerInitialize(int*, char***) {
+	fuzzer = new Fuzzer();
+
+	std::vector<uint32_t> program;
+
+	if (const char* path = std::getenv("MICROSIM_FUZZ_PROGRAM")) {
+		fuzzer->guest = true;
+
+		try {
+			program = MicroSim::load_program(path);
+		}
+		catch (const MicroSim::EmulatorError& e) {
+			std::fprintf(stderr, "MICROSIM_FUZZ_PROGRAM could not be loaded: %s\n", e.what());
+			std::exit(1);
+		}
+
+		fuzzer->input_address = DEFAULT_INPUT_ADDRESS;
+
+		if (const char* address = std::getenv("MICROSIM_FUZZ_INPUT_ADDRESS")) {
+			uint64_t value;
+
+			if (!parse_number(address, value) || value >= MicroSim::MEMORY_SIZE) {
+				std::fprintf(stderr, "MICROSIM_FUZZ_INPUT_ADDRESS must be an address in memory\n");
+				std::exit(1);
+			}
+
+			fuzzer->input_address = static_cast<uint32_t>(value);
+		}
+
+		if (fuzzer->input_address + MAX_INPUT_WORDS > MicroSim::MEMORY_SIZE) {
+			std::fprintf(stderr, "MICROSIM_FUZZ_INPUT_ADDRESS is too close to the end of memory\n");
+			std::exit(1);
+		}
+
+		// The input length goes in the word before the input
+		if (fuzzer->input_address == 0) {
+			std::fprintf(stderr, "MICROSIM_FUZZ_INPUT_ADDRESS must leave room for the input length before it\n");
+			std::exit(1);
+		}
+	}
+
+	if (const char* limit = std::getenv("MICROSIM_FUZZ_INSTRUCTION_LIMIT")) {
+		if (!parse_number(limit, fuzzer->instruction_limit) || fuzzer->instruction_limit == 0) {
+			std::fprintf(stderr, "MICROSIM_FUZZ_INSTRUCTION_LIMIT must be a positive number\n");
+			std::exit(1);
+		}
+	}
+
+	const char* differential = std::getenv("MICROSIM_FUZZ_DIFFERENTIAL");
+	fuzzer->differential = !differential || std::strcmp(differential, "0") != 0;
+
+	prepare(*fuzzer->primary, program);
+	prepare(*fuzzer->reference, program);
+
+	fuzzer->primary->set_coverage_map(guest_coverage, COVERAGE_MAP_SIZE);
+
+	fuzzer->input.reserve(MAX_INPUT_WORDS);
+
+	return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+	// Convert the input into little-endian words, padding the last word with zeroes
+	size_t words = std::min((size + 3) / 4, MAX_INPUT_WORDS);
+	fuzzer->input.assign(words, 0);
+
+	fuzzer->input_length = static_cast<uint32_t>(std::min(size, words * 4));
+
+	for (size_t i = 0; i < fuzzer->input_length; i++) {
+		fuzzer->input[i / 4] |= static_cast<uint32_t>(data[i]) << (8 * (i % 4));
+	}
+
+	fuzzer->primary->restore_snapshot();
+	write_input(*fuzzer->primary);
+
+	if (!fuzzer->differential) {
+		MicroSim::run_to_limit(*fuzzer->primary, fuzzer->instruction_limit);
+		return 0;
+	}
+
+	fuzzer->reference->restore_snapshot();
+	write_input(*fuzzer->reference);
+
+	std::string error;
+	if (!MicroSim::run_matches_step(*fuzzer->primary, *fuzzer->reference, fuzzer->instruction_limit, error)) {
+		report_mismatch(*fuzzer->primary, *fuzzer->reference);
+		std::abort();
+	}
+
+	return 0;
+}
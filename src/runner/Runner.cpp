@@ -0,0 +1,139 @@
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Emulator.hpp"
+#include "Loader.hpp"
+#include "Verify.hpp"
+
+/*
+* Headless runner: loads a program, runs it, and prints the final state.
+*
+* Usage: microsim-run [--limit N] [--quiet] [--verify] program
+*
+* With --verify, the program is also executed by stepping each instruction on a second emulator, and the final
+* state must match run() exactly. This checks that skipping idle loops has no visible effect.
+*
+* Exit codes:
+* 0: Program halted
+* 1: Invalid arguments, or the program could not be loaded or executed
+* 2: Instruction limit was reached before the program halted
+* 3: Verification failed
+*/
+
+namespace {
+	const uint64_t DEFAULT_INSTRUCTION_LIMIT = 1000000000;
+
+	void print_usage(const char* name) {
+		std::fprintf(stderr, "Usage: %s [--limit N] [--quiet] [--verify] program\n", name);
+		std::fprintf(stderr, "  --limit N  Stop after N instructions (default %llu)\n", static_cast<unsigned long long>(DEFAULT_INSTRUCTION_LIMIT));
+		std::fprintf(stderr, "  --quiet    Don't print the final state\n");
+		std::fprintf(stderr, "  --verify   Check that run() matches stepping each instruction (slow for long idle loops)\n");
+		std::fprintf(stderr, "Programs ending in .hex are read as hex words, anything else as a raw little-endian binary.\n");
+	}
+
+	void print_state(MicroSim::Emulator& emulator) {
+		const uint32_t* registers = emulator.get_registers();
+
+		for (uint8_t i = 0; i < MicroSim::USER_REGISTER_COUNT; i++) {
+			std::printf("R%-2u = 0x%05x\n", i, registers[i]);
+		}
+
+		uint8_t flags = emulator.get_flags();
+		std::printf("Z=%u C=%u N=%u V=%u\n", (flags & MicroSim::CCR_Z) != 0, (flags & MicroSim::CCR_C) != 0, (flags & MicroSim::CCR_N) != 0, (flags & MicroSim::CCR_V) != 0);
+
+		std::printf("Instructions: %llu%s%s\n", static_cast<unsigned long long>(emulator.instructions_executed()), emulator.finished() ? " (halted)" : "", emulator.idle() ? " (idle)" : "");
+	}
+}
+
+int main(int argc, char* argv[]) {
+	uint64_t instruction_limit = DEFAULT_INSTRUCTION_LIMIT;
+	bool quiet = false;
+	bool verify = false;
+	const char* path = nullptr;
+
+	for (int i = 1; i < argc; i++) {
+		if (std::strcmp(argv[i], "--limit") == 0 && i + 1 < argc) {
+			const char* limit = argv[++i];
+
+			// strtoull accepts (and wraps) negative numbers and leading whitespace, so only allow digits
+			char* end;
+			errno = 0;
+			instruction_limit = std::strtoull(limit, &end, 10);
+
+			if (*limit < '0' || *limit > '9' || *end != '\0' || errno != 0) {
+				print_usage(argv[0]);
+				return 1;
+			}
+		}
+		else if (std::strcmp(argv[i], "--quiet") == 0) {
+			quiet = true;
+		}
+		else if (std::strcmp(argv[i], "--verify") == 0) {
+			verify = true;
+		}
+		else if (argv[i][0] != '-' && path == nullptr) {
+			path = argv[i];
+		}
+		else {
+			print_usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (path == nullptr) {
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	// The emulator holds all of memory, so it is too large for the stack
+	std::unique_ptr<MicroSim::Emulator> emulator = std::make_unique<MicroSim::Emulator>();
+
+	std::vector<uint32_t> program;
+	std::string error;
+
+	try {
+		program = MicroSim::load_program(path);
+		emulator->load(program.data(), program.size());
+	}
+	catch (const MicroSim::EmulatorError& e) {
+		std::fprintf(stderr, "%s\n", e.what());
+		return 1;
+	}
+
+	if (verify) {
+		std::unique_ptr<MicroSim::Emulator> reference = std::make_unique<MicroSim::Emulator>();
+		reference->load(program.data(), program.size());
+
+		if (!MicroSim::run_matches_step(*emulator, *reference, instruction_limit, error)) {
+			std::fprintf(stderr, "Verification failed: run() and stepping ended in different states\n");
+
+			if (!quiet) {
+				std::printf("run():\n");
+				print_state(*emulator);
+				std::printf("Stepping:\n");
+				print_state(*reference);
+			}
+
+			return 3;
+		}
+	}
+	else {
+		error = MicroSim::run_to_limit(*emulator, instruction_limit);
+	}
+
+	if (!error.empty()) {
+		std::fprintf(stderr, "%s\n", error.c_str());
+		return 1;
+	}
+
+	if (!quiet) {
+		print_state(*emulator);
+	}
+
+	return emulator->finished() ? 0 : 2;
+}
@@ -0,0 +1,166 @@
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Emulator.hpp"
+#include "Verify.hpp"
+
+/*
+* Regression tests for idle-loop fast-forwarding in Emulator::run.
+*
+* Each test checks the result of run() directly, and also that it matches stepping each instruction.
+*/
+
+using namespace MicroSim;
+
+namespace {
+	int failures = 0;
+
+	void check(bool condition, const char* test, const char* description) {
+		if (!condition) {
+			std::fprintf(stderr, "FAILED: %s: %s\n", test, description);
+			failures++;
+		}
+	}
+
+	uint32_t encode(Opcode opcode, AddressingMode mode, uint8_t register_a, uint32_t operand) {
+		// Shift as unsigned, since opcodes from 0b10000 upwards would overflow an int
+		return (static_cast<uint32_t>(opcode) << 27) | (static_cast<uint32_t>(mode) << 25) | (static_cast<uint32_t>(register_a) << 20) | operand;
+	}
+
+	std::unique_ptr<Emulator> load(const std::vector<uint32_t>& program) {
+		std::unique_ptr<Emulator> emulator = std::make_unique<Emulator>();
+		emulator->load(program.data(), program.size());
+		return emulator;
+	}
+
+	bool matches_step(const std::vector<uint32_t>& program, uint64_t instruction_limit) {
+		std::unique_ptr<Emulator> fast = load(program);
+		std::unique_ptr<Emulator> reference = load(program);
+
+		std::string error;
+		return MicroSim::run_matches_step(*fast, *reference, instruction_limit, error) && error.empty();
+	}
+
+	// JMP 0
+	const std::vector<uint32_t> JMP_TO_SELF = {
+		encode(OP_JMP, MODE_DIRECT, 0, 0)
+	};
+
+	// Poll address 0x100 until it is non-zero, which never happens
+	const std::vector<uint32_t> POLLING_LOOP = {
+		encode(OP_LDR, MODE_DIRECT, 1, 0x100),
+		encode(OP_CMP, MODE_IMMEDIATE, 1, 0),
+		encode(OP_BEQ, MODE_DIRECT, 0, 0),
+		encode(OP_HLT, MODE_IMPLICIT, 0, 0)
+	};
+
+	// The same loop, but it stores every iteration, so it must not be skipped
+	const std::vector<uint32_t> STORING_LOOP = {
+		encode(OP_LDR, MODE_DIRECT, 1, 0x100),
+		encode(OP_STR, MODE_DIRECT, 1, 0x101),
+		encode(OP_CMP, MODE_IMMEDIATE, 1, 0),
+		encode(OP_BEQ, MODE_DIRECT, 0, 0),
+		encode(OP_HLT, MODE_IMPLICIT, 0, 0)
+	};
+
+	// Count down from 5, then halt
+	const std::vector<uint32_t> COUNTING_LOOP = {
+		encode(OP_MOV, MODE_IMMEDIATE, 1, 5),
+		encode(OP_SUB, MODE_IMMEDIATE, 1, 1),
+		encode(OP_BNE, MODE_DIRECT, 0, 1),
+		encode(OP_HLT, MODE_IMPLICIT, 0, 0)
+	};
+
+	void test_jmp_to_self() {
+		const char* test = "jmp_to_self";
+
+		std::unique_ptr<Emulator> emulator = load(JMP_TO_SELF);
+		uint64_t executed = emulator->run(1000000000);
+
+		check(executed == 1000000000, test, "all instructions are credited");
+		check(emulator->idle(), test, "loop is detected as idle");
+		check(!emulator->finished(), test, "program doesn't halt");
+		check(emulator->get_registers()[PC_INDEX] == 0, test, "PC stays on the jump");
+		check(matches_step(JMP_TO_SELF, 10001), test, "run() matches stepping");
+	}
+
+	void test_polling_loop() {
+		const char* test = "polling_loop";
+
+		std::unique_ptr<Emulator> emulator = load(POLLING_LOOP);
+		uint64_t executed = emulator->run(1000000000);
+
+		check(executed == 1000000000, test, "all instructions are credited");
+		check(emulator->idle(), test, "loop is detected as idle");
+		check(matches_step(POLLING_LOOP, 30000), test, "run() matches stepping");
+	}
+
+	void test_limit_mid_iteration() {
+		const char* test = "limit_mid_iteration";
+
+		// The loop is 3 instructions long, so the limit lands just after the LDR
+		std::unique_ptr<Emulator> emulator = load(POLLING_LOOP);
+		uint64_t executed = emulator->run(1000);
+
+		check(executed == 1000, test, "exactly the limit is executed");
+		check(emulator->idle(), test, "loop is detected as idle");
+		check(emulator->get_registers()[PC_INDEX] == 1, test, "PC is part way through the loop");
+		check(matches_step(POLLING_LOOP, 1000), test, "run() matches stepping");
+	}
+
+	void test_store_prevents_skipping() {
+		const char* test = "store_prevents_skipping";
+
+		std::unique_ptr<Emulator> emulator = load(STORING_LOOP);
+		uint64_t executed = emulator->run(100000);
+
+		check(executed == 100000, test, "exactly the limit is executed");
+		check(!emulator->idle(), test, "loop is not detected as idle");
+		check(matches_step(STORING_LOOP, 10000), test, "run() matches stepping");
+	}
+
+	void test_terminating_loop() {
+		const char* test = "terminating_loop";
+
+		std::unique_ptr<Emulator> emulator = load(COUNTING_LOOP);
+		uint64_t executed = emulator->run(1000);
+
+		check(executed == 12, test, "program halts after 12 instructions");
+		check(emulator->finished(), test, "program halts");
+		check(!emulator->idle(), test, "loop is not detected as idle");
+		check(matches_step(COUNTING_LOOP, 1000), test, "run() matches stepping");
+	}
+
+	void test_unlimited_run_saturates() {
+		const char* test = "unlimited_run_saturates";
+
+		std::unique_ptr<Emulator> emulator = load(POLLING_LOOP);
+		emulator->run(10);
+		emulator->run(UINT64_MAX);
+
+		check(emulator->instructions_executed() > UINT64_MAX - 3, test, "counter fills up to the last whole iteration");
+
+		uint64_t count = emulator->instructions_executed();
+		emulator->run(UINT64_MAX);
+
+		check(emulator->instructions_executed() >= count, test, "counter doesn't wrap around");
+	}
+}
+
+int main() {
+	test_jmp_to_self();
+	test_polling_loop();
+	test_limit_mid_iteration();
+	test_store_prevents_skipping();
+	test_terminating_loop();
+	test_unlimited_run_saturates();
+
+	if (failures != 0) {
+		std::fprintf(stderr, "%d checks failed\n", failures);
+		return 1;
+	}
+
+	return 0;
+}